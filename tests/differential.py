@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+# Differential test of one corpus program: the plain translation must print
+# NAME.out given NAME.in, and so must the translation under every option
+# that only changes the code, under both portable runtimes, --run, and
+# --asm where it can be assembled.
+# Then --watch follows a series of edits, each of which must leave NAME.cpp
+# equal to the one-shot translation of the edited text.
+#
+# differential.py --ss SSHARP --cxx COMPILER [--work DIR] NAME.ss
+import argparse
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+MODES = [[], ["-O"], ["-O2"], ["--memoize"], ["--parallel"], ["--explicit-stack"],
+         ["-O", "--memoize"], ["-O2", "--parallel"], ["-O", "--explicit-stack"]]
+# The fast runtime reads and writes the numbers itself; the modes only
+# change the code around read() and write()
+RUNTIMES = [("stdio", MODES), ("fast", [[], ["-O"], ["-O2"]])]
+
+
+def translate(args, runtime, flags, path):
+    r = subprocess.run([args.ss, "--runtime", runtime] + flags + [path], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    if r.returncode != 0 or r.stdout.startswith(b"error"):
+        raise AssertionError("--runtime %s %s %s: translation failed\n%s" % (runtime, " ".join(flags), path, r.stderr.decode(errors="replace")))
+    return r.stdout
+
+
+def compile_cpp(args, source, exe):
+    cxx = args.cxx
+    if os.path.basename(cxx).lower() in ("cl", "cl.exe"):
+        cmd = [cxx, "/nologo", "/std:c++17", "/EHsc", "/O2", source, "/Fe" + exe]
+    else:
+        cmd = [cxx, "-std=c++17", "-O1", source, "-o", exe, "-pthread"]
+    r = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    if r.returncode != 0:
+        raise AssertionError("%s does not compile\n%s" % (source, r.stdout.decode(errors="replace")))
+
+
+def run(cmd, data):
+    r = subprocess.run(cmd, input=data, stdout=subprocess.PIPE, stderr=subprocess.PIPE, timeout=120)
+    if r.returncode != 0:
+        raise AssertionError("%s exited with %d\n%s" % (" ".join(cmd), r.returncode, r.stderr.decode(errors="replace")))
+    return r.stdout.replace(b"\r\n", b"\n")
+
+
+def check(what, got, expected):
+    if got != expected:
+        raise AssertionError("%s printed\n%s\ninstead of\n%s" % (what, got.decode(), expected.decode()))
+
+
+def outputs(args, path, work, data, expected):
+    exe = ".exe" if os.name == "nt" else ""
+    for runtime, modes in RUNTIMES:
+        for i, flags in enumerate(modes):
+            name = os.path.join(work, "%s%d" % (runtime, i))
+            with open(name + ".cpp", "wb") as f:
+                f.write(translate(args, runtime, flags, path))
+            compile_cpp(args, name + ".cpp", name + exe)
+            check(" ".join(["--runtime", runtime] + flags), run([name + exe], data), expected)
+    check("--run", run([args.ss, "--run", path], data), expected)
+    if platform.system() == "Linux" and platform.machine() in ("x86_64", "AMD64") and shutil.which("cc"):
+        source = os.path.join(work, "a.s")
+        r = subprocess.run([args.ss, "--asm", path], stdout=subprocess.PIPE)
+        with open(source, "wb") as f:
+            f.write(r.stdout)
+        subprocess.run(["cc", "-nostdlib", "-static", source, "-o", os.path.join(work, "a")], check=True,
+                       stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        check("--asm", run([os.path.join(work, "a")], data), expected)
+
+
+# Each edit changes the size of the file, which is what --watch polls with the time
+def edits(text):
+    yield text + "\nextra x { x + 1 }\n"
+    yield text.replace("main", "main2", 1) + "\nmain { 0 }\n"
+    yield text + "\nbroken x { x + }\n"
+    yield text.replace("(", "((", 1).replace(")", "))", 1)
+    yield text[:len(text) // 2]
+    yield "spare a { a * 2 }\n" + text
+    yield text
+
+
+def watch(args, runtime, path, work):
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+    copy = os.path.join(work, "w.ss")
+    target = os.path.join(work, "w.cpp")
+    reference = os.path.join(work, "ref.ss")
+
+    def put(name, data):
+        with open(name + ".tmp", "w", encoding="utf-8", newline="\n") as f:
+            f.write(data)
+        os.replace(name + ".tmp", name)
+
+    def expect(data):
+        put(reference, data)
+        r = subprocess.run([args.ss, "--runtime", runtime, reference], stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+        deadline = time.time() + 60
+        while time.time() < deadline:
+            try:
+                with open(target, "rb") as f:
+                    if f.read() == r.stdout:
+                        return
+            except OSError:
+                pass
+            time.sleep(0.02)
+        raise AssertionError("--watch did not follow the edit to\n" + data)
+
+    put(copy, text)
+    proc = subprocess.Popen([args.ss, "--runtime", runtime, "--watch", copy], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    try:
+        expect(text)
+        for edited in edits(text):
+            time.sleep(0.05)
+            put(copy, edited)
+            expect(edited)
+    finally:
+        proc.kill()
+        proc.wait()
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--ss", required=True)
+    parser.add_argument("--cxx", required=True)
+    parser.add_argument("--work")
+    parser.add_argument("program")
+    args = parser.parse_args()
+    base = os.path.splitext(args.program)[0]
+    data = b""
+    if os.path.exists(base + ".in"):
+        with open(base + ".in", "rb") as f:
+            data = f.read()
+    with open(base + ".out", "rb") as f:
+        expected = f.read().replace(b"\r\n", b"\n")
+    work = args.work or tempfile.mkdtemp(prefix="ssharp-")
+    os.makedirs(work, exist_ok=True)
+    try:
+        outputs(args, args.program, work, data, expected)
+        watch(args, "fast", args.program, work)
+    except AssertionError as e:
+        print("%s: %s" % (args.program, e), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())